@@ -0,0 +1,60 @@
+#pragma once
+#include "manifest.hpp"
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+namespace athes::unpack {
+
+struct DeltaStats {
+    size_t unchanged        = 0;
+    size_t changed          = 0;
+    uint64_t unchanged_size = 0;
+    uint64_t changed_size   = 0;
+};
+
+class Delta {
+public:
+    DeltaStats stats;
+
+    /**
+     * Prepare a delta against a previous output described by its manifest.
+     * The previous output is used to copy the unchanged binaries. Without it,
+     * every binary is written from the movie, only the patch benefits from the delta.
+     * The previous output is trusted to match the manifest, only its size is checked.
+     * Throws a std::runtime_error when the previous output cannot be opened or when
+     * its size differs from the manifest.
+     */
+    Delta(Manifest base, std::optional<std::string> base_path = {}, std::ostream* patch = nullptr);
+
+    /**
+     * Find the binary of the previous output matching the entry.
+     * Binaries are matched by name first, then by content hash.
+     */
+    const ManifestEntry* find(const ManifestEntry& entry) const;
+
+    /**
+     * Write the chunks described by the manifest to the output.
+     * Unchanged binaries are copied from the previous output, using the filesystem
+     * copy (or reflink) when supported, and only the changed ones are written.
+     * When a patch stream was given, a binary patch against the previous output
+     * is written to it as well.
+     */
+    void write(const std::vector<Chunk>& chunks, const Manifest& manifest, std::FILE* output);
+
+protected:
+    Manifest base;
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> base_file;
+    std::ostream* patch;
+
+    std::unordered_map<std::string, const ManifestEntry*> by_name;
+    std::unordered_map<uint64_t, const ManifestEntry*> by_hash;
+};
+
+/**
+ * Rebuild an output from the previous output and a patch written by Delta::write.
+ * Throws a std::runtime_error when the patch does not apply to the previous output.
+ */
+void apply_patch(std::FILE* base, std::istream& patch, std::FILE* output);
+}
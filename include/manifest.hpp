@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace athes::unpack {
+
+/**
+ * Compute the 64-bit xxHash (XXH64) of the given buffer.
+ */
+uint64_t xxh64(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+/**
+ * A view over a binary written to the output.
+ * The data is owned by the movie and must outlive the chunk.
+ */
+struct Chunk {
+    std::string name;
+    const uint8_t* data;
+    size_t size;
+};
+
+struct ManifestEntry {
+    std::string name;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t hash;
+};
+
+class Manifest {
+public:
+    std::vector<ManifestEntry> entries;
+
+    Manifest() = default;
+    /**
+     * Build the manifest of the chunks, written in order.
+     * The chunks are hashed in parallel.
+     */
+    Manifest(const std::vector<Chunk>& chunks);
+
+    /**
+     * Total size of the output described by the manifest.
+     */
+    uint64_t size() const;
+
+    void write(std::ostream& stream) const;
+    /**
+     * Read a manifest previously written with `write`.
+     * Throws a std::runtime_error when the manifest is malformed.
+     */
+    static Manifest read(std::istream& stream);
+
+    /**
+     * Check the buffer against the manifest, hashing the entries in parallel.
+     * Return the entries that do not match. An entry that lies outside of the
+     * buffer is reported as mismatching.
+     */
+    std::vector<const ManifestEntry*> verify(const uint8_t* data, size_t size) const;
+};
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include "delta.hpp"
+#include "manifest.hpp"
 #include "string_finder.hpp"
 #include <abc/parser/Parser.hpp>
 #include <optional>
@@ -40,6 +42,16 @@ public:
 
     std::optional<std::string> write_binaries(std::ostream& file);
     std::optional<std::string> write_binaries(swf::StreamWriter& stream);
+    /**
+     * Write the binaries to the file and fill the manifest describing the output.
+     * The binaries are hashed in parallel while being written.
+     */
+    std::optional<std::string> write_binaries(std::ostream& file, Manifest& manifest);
+    /**
+     * Write the binaries to the file, reusing the unchanged ones from the delta's
+     * previous output, and fill the manifest describing the output.
+     */
+    std::optional<std::string> write_binaries(std::FILE* file, Delta& delta, Manifest& manifest);
 
 protected:
     bool match_target(StringFinder& finder, std::string& target);
@@ -19,6 +19,7 @@ double elapsled(TimePoint start, TimePoint stop);
 double elapsled(TimePoint tp);
 
 void read_from_stdin(std::vector<uint8_t>& file);
+void read_from_file(std::string const& path, std::vector<uint8_t>& file);
 
 std::string get_unit(std::list<std::string> const& units, double& value, double factor = 1024);
 std::string fmt_unit(std::list<std::string> const& units, double value, double factor = 1024);
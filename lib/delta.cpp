@@ -0,0 +1,231 @@
+#include "delta.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace athes::unpack {
+namespace {
+    constexpr char patch_magic[8]   = { 'U', 'N', 'P', 'K', 'D', 'L', 'T', 'A' };
+    constexpr uint8_t patch_version = 1;
+    constexpr size_t buffer_size    = 1 << 16;
+
+    enum class PatchOp : uint8_t {
+        End  = 0,
+        Copy = 1, // offset, size and hash of a range of the previous output
+        Data = 2, // size followed by the data
+    };
+
+    void write_u64(std::ostream& stream, uint64_t value) {
+        char bytes[8];
+        for (auto& byte : bytes) {
+            byte = static_cast<char>(value & 0xff);
+            value >>= 8;
+        }
+        stream.write(bytes, sizeof(bytes));
+    }
+    uint64_t read_u64(std::istream& stream) {
+        uint8_t bytes[8];
+        if (!stream.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+            throw std::runtime_error("Unexpected end of patch.");
+
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i)
+            value = (value << 8) | bytes[i];
+        return value;
+    }
+
+    void write_data(std::FILE* output, const uint8_t* data, size_t size) {
+        if (std::fwrite(data, 1, size, output) != size)
+            throw std::runtime_error(std::strerror(errno));
+    }
+    void read_data(std::FILE* base, uint64_t offset, uint8_t* data, size_t size) {
+        if (std::fseek(base, static_cast<long>(offset), SEEK_SET) != 0)
+            throw std::runtime_error(std::strerror(errno));
+        if (std::fread(data, 1, size, base) != size)
+            throw std::runtime_error("The previous output is truncated.");
+    }
+
+    /**
+     * Copy a range of the previous output to the output.
+     * On Linux, copy_file_range lets the filesystem share the extents (reflink)
+     * or copy in-kernel. It falls back to a buffered copy otherwise.
+     */
+    void copy_range(std::FILE* base, std::FILE* output, uint64_t offset, uint64_t size) {
+#ifdef __linux__
+        if (std::fflush(output) == 0) {
+            loff_t off_in = static_cast<loff_t>(offset);
+            bool copied   = false;
+            while (size > 0) {
+                auto n = copy_file_range(fileno(base), &off_in, fileno(output), nullptr, size, 0);
+                if (n <= 0)
+                    break;
+                size -= n;
+                copied = true;
+            }
+            offset = off_in;
+
+            // copy_file_range moved the file offset behind the stream's back.
+            // The output is written sequentially, so its end is the current position.
+            if (copied && std::fseek(output, 0, SEEK_END) != 0)
+                throw std::runtime_error(std::strerror(errno));
+        }
+#endif
+        std::vector<uint8_t> buffer(std::min<uint64_t>(size, buffer_size));
+        while (size > 0) {
+            const auto n = std::min<uint64_t>(size, buffer.size());
+            read_data(base, offset, buffer.data(), n);
+            write_data(output, buffer.data(), n);
+            offset += n;
+            size -= n;
+        }
+    }
+
+    uint64_t file_size(std::FILE* file) {
+        if (std::fseek(file, 0, SEEK_END) != 0)
+            throw std::runtime_error(std::strerror(errno));
+        return static_cast<uint64_t>(std::ftell(file));
+    }
+}
+
+Delta::Delta(Manifest base, std::optional<std::string> base_path, std::ostream* patch)
+    : base(std::move(base)), base_file(nullptr, &std::fclose), patch(patch) {
+    if (base_path) {
+        base_file.reset(std::fopen(base_path->c_str(), "rb"));
+        if (!base_file)
+            throw std::runtime_error(*base_path + ": " + std::strerror(errno));
+
+        // The previous output is trusted to match its manifest, only its size is checked
+        if (file_size(base_file.get()) != this->base.size())
+            throw std::runtime_error(*base_path + ": size does not match its manifest.");
+    }
+
+    for (auto& entry : this->base.entries) {
+        by_name.emplace(entry.name, &entry);
+        by_hash.emplace(entry.hash, &entry);
+    }
+}
+
+const ManifestEntry* Delta::find(const ManifestEntry& entry) const {
+    const auto& same = [&entry](const ManifestEntry* other) {
+        return other->hash == entry.hash && other->size == entry.size;
+    };
+
+    const auto& name = by_name.find(entry.name);
+    if (name != by_name.end() && same(name->second))
+        return name->second;
+
+    // The binary might have been renamed
+    const auto& hash = by_hash.find(entry.hash);
+    if (hash != by_hash.end() && same(hash->second))
+        return hash->second;
+
+    return nullptr;
+}
+
+void Delta::write(const std::vector<Chunk>& chunks, const Manifest& manifest, std::FILE* output) {
+    stats = {};
+    if (patch) {
+        patch->write(patch_magic, sizeof(patch_magic));
+        patch->put(static_cast<char>(patch_version));
+        write_u64(*patch, base.size());
+        write_u64(*patch, manifest.size());
+    }
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const auto& chunk = chunks[i];
+        const auto match  = find(manifest.entries[i]);
+
+        if (match) {
+            ++stats.unchanged;
+            stats.unchanged_size += chunk.size;
+        } else {
+            ++stats.changed;
+            stats.changed_size += chunk.size;
+        }
+
+        if (match && base_file)
+            copy_range(base_file.get(), output, match->offset, match->size);
+        else
+            write_data(output, chunk.data, chunk.size);
+
+        if (!patch)
+            continue;
+
+        if (match) {
+            patch->put(static_cast<char>(PatchOp::Copy));
+            write_u64(*patch, match->offset);
+            write_u64(*patch, match->size);
+            write_u64(*patch, match->hash);
+        } else {
+            patch->put(static_cast<char>(PatchOp::Data));
+            write_u64(*patch, chunk.size);
+            patch->write(reinterpret_cast<const char*>(chunk.data), chunk.size);
+        }
+    }
+
+    if (patch)
+        patch->put(static_cast<char>(PatchOp::End));
+    if (std::fflush(output) != 0)
+        throw std::runtime_error(std::strerror(errno));
+}
+
+void apply_patch(std::FILE* base, std::istream& patch, std::FILE* output) {
+    char magic[sizeof(patch_magic)];
+    if (!patch.read(magic, sizeof(magic)) || std::memcmp(magic, patch_magic, sizeof(magic)) != 0)
+        throw std::runtime_error("Invalid patch header.");
+
+    const auto version = patch.get();
+    if (version != patch_version)
+        throw std::runtime_error("Unsupported patch version: " + std::to_string(version));
+
+    const auto base_size   = read_u64(patch);
+    const auto target_size = read_u64(patch);
+    if (file_size(base) != base_size)
+        throw std::runtime_error("The patch does not apply to this file: size mismatch.");
+
+    std::vector<uint8_t> buffer;
+    uint64_t written = 0;
+    for (;;) {
+        const auto op = patch.get();
+        if (op == static_cast<int>(PatchOp::End))
+            break;
+
+        if (op == static_cast<int>(PatchOp::Copy)) {
+            const auto offset = read_u64(patch);
+            const auto size   = read_u64(patch);
+            const auto hash   = read_u64(patch);
+            if (offset > base_size || size > base_size - offset || size > target_size - written)
+                throw std::runtime_error("Invalid patch: range outside of the previous output.");
+
+            buffer.resize(size);
+            read_data(base, offset, buffer.data(), size);
+            if (xxh64(buffer.data(), size) != hash)
+                throw std::runtime_error("The patch does not apply to this file: hash mismatch.");
+        } else if (op == static_cast<int>(PatchOp::Data)) {
+            const auto size = read_u64(patch);
+            if (size > target_size - written)
+                throw std::runtime_error("Invalid patch: output size mismatch.");
+
+            buffer.resize(size);
+            if (!patch.read(reinterpret_cast<char*>(buffer.data()), size))
+                throw std::runtime_error("Unexpected end of patch.");
+        } else {
+            throw std::runtime_error("Invalid patch operation.");
+        }
+
+        write_data(output, buffer.data(), buffer.size());
+        written += buffer.size();
+    }
+
+    if (written != target_size)
+        throw std::runtime_error("Invalid patch: output size mismatch.");
+    if (std::fflush(output) != 0)
+        throw std::runtime_error(std::strerror(errno));
+}
+}
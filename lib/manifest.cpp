@@ -0,0 +1,184 @@
+#include "manifest.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace athes::unpack {
+namespace {
+    constexpr const char* magic = "unpacker-manifest";
+    constexpr int manifest_version = 1;
+
+    constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    inline uint64_t read64(const uint8_t* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i)
+            v = (v << 8) | p[i];
+        return v;
+    }
+    inline uint32_t read32(const uint8_t* p) {
+        return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    }
+    inline uint64_t xxh_round(uint64_t acc, uint64_t input) {
+        acc += input * prime2;
+        return rotl(acc, 31) * prime1;
+    }
+    inline uint64_t merge_round(uint64_t acc, uint64_t val) {
+        acc ^= xxh_round(0, val);
+        return acc * prime1 + prime4;
+    }
+
+    /**
+     * Call func(i) for each i in [0, count), spread across the available cores.
+     */
+    template <typename F> void parallel_for(size_t count, F&& func) {
+        const size_t cores   = std::max(1u, std::thread::hardware_concurrency());
+        const size_t workers = std::min(cores, count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; ++i)
+                func(i);
+            return;
+        }
+
+        std::atomic<size_t> next { 0 };
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < workers; ++t)
+            threads.emplace_back([&]() {
+                for (size_t i; (i = next++) < count;)
+                    func(i);
+            });
+        for (auto& thread : threads)
+            thread.join();
+    }
+}
+
+uint64_t xxh64(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint8_t* p   = data;
+    const uint8_t* end = data + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+
+        for (const uint8_t* limit = end - 32; p <= limit; p += 32) {
+            v1 = xxh_round(v1, read64(p));
+            v2 = xxh_round(v2, read64(p + 8));
+            v3 = xxh_round(v3, read64(p + 16));
+            v4 = xxh_round(v4, read64(p + 24));
+        }
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+    } else {
+        h = seed + prime5;
+    }
+
+    h += size;
+    for (; p + 8 <= end; p += 8)
+        h = rotl(h ^ xxh_round(0, read64(p)), 27) * prime1 + prime4;
+    if (p + 4 <= end) {
+        h = rotl(h ^ (read32(p) * prime1), 23) * prime2 + prime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+        h = rotl(h ^ (*p * prime5), 11) * prime1;
+
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+Manifest::Manifest(const std::vector<Chunk>& chunks) {
+    uint64_t offset = 0;
+    entries.reserve(chunks.size());
+    for (auto& chunk : chunks) {
+        entries.push_back({ chunk.name, offset, chunk.size, 0 });
+        offset += chunk.size;
+    }
+
+    parallel_for(chunks.size(), [&](size_t i) {
+        entries[i].hash = xxh64(chunks[i].data, chunks[i].size);
+    });
+}
+
+uint64_t Manifest::size() const {
+    if (entries.empty())
+        return 0;
+    return entries.back().offset + entries.back().size;
+}
+
+void Manifest::write(std::ostream& stream) const {
+    stream << magic << ' ' << manifest_version << '\n' << size() << '\n';
+    for (auto& entry : entries) {
+        stream << std::hex << std::setw(16) << std::setfill('0') << entry.hash << std::dec << ' '
+               << entry.offset << ' ' << entry.size << ' ' << entry.name << '\n';
+    }
+}
+
+Manifest Manifest::read(std::istream& stream) {
+    Manifest manifest;
+    std::string header;
+    int version   = 0;
+    uint64_t size = 0;
+
+    if (!(stream >> header >> version >> size) || header != magic)
+        throw std::runtime_error("Invalid manifest header.");
+    if (version != manifest_version)
+        throw std::runtime_error("Unsupported manifest version: " + std::to_string(version));
+
+    std::string line;
+    std::getline(stream, line);
+    while (std::getline(stream, line)) {
+        if (line.empty())
+            continue;
+
+        std::istringstream ss(line);
+        ManifestEntry entry;
+        if (!(ss >> std::hex >> entry.hash >> std::dec >> entry.offset >> entry.size))
+            throw std::runtime_error("Invalid manifest entry: " + line);
+
+        // The name is the remaining of the line, without the separator
+        ss.get();
+        std::getline(ss, entry.name);
+        manifest.entries.push_back(std::move(entry));
+    }
+
+    if (manifest.size() != size)
+        throw std::runtime_error("Manifest size does not match its entries.");
+    return manifest;
+}
+
+std::vector<const ManifestEntry*> Manifest::verify(const uint8_t* data, size_t size) const {
+    std::vector<uint8_t> valid(entries.size(), 0);
+    parallel_for(entries.size(), [&](size_t i) {
+        const auto& entry = entries[i];
+        if (entry.offset > size || entry.size > size - entry.offset)
+            return;
+        valid[i] = xxh64(data + entry.offset, entry.size) == entry.hash;
+    });
+
+    std::vector<const ManifestEntry*> mismatches;
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (!valid[i])
+            mismatches.push_back(&entries[i]);
+    return mismatches;
+}
+}
@@ -1,6 +1,7 @@
 #include "unpacker.hpp"
 #include <cpr/cpr.h>
 #include <cstring>
+#include <future>
 
 namespace athes::unpack {
 void download(std::string url, std::vector<uint8_t>& buffer) {
@@ -15,6 +16,34 @@ void download(std::string url, std::vector<uint8_t>& buffer) {
         throw std::runtime_error(r.error.message);
 }
 
+namespace {
+    /**
+     * Collect the binaries in order and call func with views over their data.
+     * Every binary's data is kept alive until func returns, unlike the plain
+     * write_binaries which handles one at a time: the whole output is held in memory.
+     * Return the name of the first missing binary, if any.
+     */
+    template <typename F> std::optional<std::string> with_chunks(Unpacker& unp, F&& func) {
+        using Data = std::decay_t<decltype(std::declval<swf::DefineBinaryDataTag&>().getData())>;
+        std::vector<Data> data;
+        std::vector<Chunk> chunks;
+
+        data.reserve(unp.order.size());
+        chunks.reserve(unp.order.size());
+        for (auto& name : unp.order) {
+            const auto& it = unp.binaries.find(name);
+            if (it == unp.binaries.end())
+                return name;
+
+            const auto& bin = data.emplace_back(it->second->getData());
+            chunks.push_back({ name, bin->raw(), bin->size() });
+        }
+
+        func(chunks);
+        return {};
+    }
+}
+
 Unpacker::Unpacker(std::unique_ptr<swf::StreamReader> stream)
     : stream(std::move(stream)), buffer() {
     order    = {};
@@ -155,6 +184,25 @@ std::optional<std::string> Unpacker::write_binaries(swf::StreamWriter& stream) {
     return {};
 }
 
+std::optional<std::string> Unpacker::write_binaries(std::ostream& file, Manifest& manifest) {
+    return with_chunks(*this, [&](const std::vector<Chunk>& chunks) {
+        auto hashing = std::async(std::launch::async, [&chunks]() { return Manifest(chunks); });
+        for (auto& chunk : chunks)
+            file.write(reinterpret_cast<const char*>(chunk.data), chunk.size);
+
+        manifest = hashing.get();
+    });
+}
+
+std::optional<std::string>
+Unpacker::write_binaries(std::FILE* file, Delta& delta, Manifest& manifest) {
+    return with_chunks(*this, [&](const std::vector<Chunk>& chunks) {
+        // The hashes are needed beforehand to find the unchanged binaries
+        manifest = Manifest(chunks);
+        delta.write(chunks, manifest, file);
+    });
+}
+
 bool Unpacker::match_target(StringFinder& finder, std::string& target) {
     uint32_t chr = 0;
     for (const char& c : target) {
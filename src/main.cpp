@@ -2,6 +2,7 @@
 #include "unpacker.hpp"
 #include "utils.hpp"
 #include <argparse/argparse.hpp>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 
@@ -13,6 +14,90 @@ namespace utils = athes::utils;
 
 static utils::Logger logger;
 
+using File = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+
+static Manifest read_manifest(std::string path) {
+    std::ifstream file(path);
+    if (!file)
+        throw std::runtime_error(fmt::format("Unable to open {}", path));
+    return Manifest::read(file);
+}
+
+static File open_file(std::string path, const char* mode) {
+    File file(std::fopen(path.c_str(), mode), &std::fclose);
+    if (!file)
+        throw std::runtime_error(fmt::format("Unable to open {}: {}", path, std::strerror(errno)));
+    return file;
+}
+
+static File open_output(std::string output) {
+    if (output != "-")
+        return open_file(output, "wb");
+
+    if (std::ferror(std::freopen(nullptr, "wb", stdout)))
+        throw std::runtime_error(std::strerror(errno));
+    // stdout is not ours to close
+    return File(stdout, [](std::FILE*) { return 0; });
+}
+
+static int verify(std::string output, std::string manifest_path) {
+    Manifest manifest;
+    std::vector<uint8_t> buffer;
+
+    logger.info("Verifying {} against {}. ", output, manifest_path);
+    try {
+        manifest = read_manifest(manifest_path);
+
+        if (output == "-")
+            utils::read_from_stdin(buffer);
+        else
+            utils::read_from_file(output, buffer);
+    } catch (const std::exception& err) {
+        logger.error("Error: {}\n", err.what());
+        return 2;
+    }
+
+    auto mismatches = manifest.verify(buffer.data(), buffer.size());
+    logger.info("\n");
+    for (auto entry : mismatches)
+        logger.error(
+            "Mismatch: {} (offset: {}, size: {})\n", entry->name, entry->offset, entry->size);
+
+    if (buffer.size() != manifest.size()) {
+        logger.error("Size mismatch: expected {} bytes, got {}\n", manifest.size(), buffer.size());
+        return 3;
+    }
+    if (!mismatches.empty())
+        return 3;
+
+    logger.info("{} binaries verified.\n", manifest.entries.size());
+    return 0;
+}
+
+static int apply(std::string output, std::optional<std::string> base_path, std::string patch_path) {
+    if (!base_path) {
+        logger.error("The previous output is required to apply a patch, see --base.\n");
+        return 1;
+    }
+
+    logger.info("Applying {} to {}. ", patch_path, *base_path);
+    try {
+        std::ifstream patch(patch_path, std::ios::binary);
+        if (!patch)
+            throw std::runtime_error(fmt::format("Unable to open {}", patch_path));
+
+        auto base = open_file(*base_path, "rb");
+        auto file = open_output(output);
+        apply_patch(base.get(), patch, file.get());
+    } catch (const std::exception& err) {
+        logger.error("Error: {}\n", err.what());
+        return 2;
+    }
+
+    logger.info("\n");
+    return 0;
+}
+
 int main(int argc, char const* argv[]) {
     int verbosity = 0;
     arg::ArgumentParser program("unpacker", athes::unpack::version, arg::default_arguments::help);
@@ -35,6 +120,19 @@ int main(int argc, char const* argv[]) {
     program.add_argument("-i")
         .help("The file url to unpack. Can be a file from the filesystem or an url to download.")
         .default_value(std::string { "https://www.transformice.com/Transformice.swf" });
+    program.add_argument("-m", "--manifest")
+        .help("Write a manifest of the binaries (name, offset, size and hash) to this file.");
+    program.add_argument("--verify")
+        .help("Verify the output file against the given manifest instead of unpacking.");
+    program.add_argument("--base").help(
+        "The previous output. Unchanged binaries are copied from it instead of being written. "
+        "It is trusted to match --base-manifest, see --verify.");
+    program.add_argument("--base-manifest")
+        .help("The manifest of the previous output. Enables the delta mode.");
+    program.add_argument("--patch").help(
+        "Write a binary patch against the previous output to this file. Requires --base-manifest.");
+    program.add_argument("--apply-patch")
+        .help("Rebuild the output from the previous output (--base) and the given patch.");
     program.add_argument("output").help("The ouput file.").required();
 
     try {
@@ -52,6 +150,29 @@ int main(int argc, char const* argv[]) {
 
     const auto input  = program.get("-i");
     const auto output = program.get("output");
+    if (auto verify_path = program.present("--verify"))
+        return verify(output, *verify_path);
+
+    if (auto base = program.present("--base")) {
+        std::error_code ec;
+        if (*base == output || std::filesystem::equivalent(*base, output, ec)) {
+            logger.error("The previous output cannot be overwritten, use another output file.\n");
+            return 1;
+        }
+    }
+
+    if (auto patch_path = program.present("--apply-patch"))
+        return apply(output, program.present("--base"), *patch_path);
+
+    const auto manifest_path      = program.present("--manifest");
+    const auto base_manifest_path = program.present("--base-manifest");
+    const auto patch_path         = program.present("--patch");
+    if (!base_manifest_path && (patch_path || program.present("--base"))) {
+        logger.error("The delta mode requires the manifest of the previous output, see "
+                     "--base-manifest.\n");
+        return 1;
+    }
+
     const bool is_url = input.substr(0, 7) == "http://" || input.substr(0, 8) == "https://";
 
     utils::TimePoints tps = { { "start", utils::now() } };
@@ -105,14 +226,44 @@ int main(int argc, char const* argv[]) {
 
     // Write binaries in the right order to the output file
     std::optional<std::string> missing_binary;
-    if (output == "-") {
+    std::optional<DeltaStats> delta_stats;
+    Manifest manifest;
+    const auto& write_output = [&](std::ostream& file) {
+        if (manifest_path)
+            return unp->write_binaries(file, manifest);
+        return unp->write_binaries(file);
+    };
+
+    if (base_manifest_path) {
+        try {
+            std::ofstream patch;
+            if (patch_path) {
+                patch.open(*patch_path, std::ios::binary);
+                if (!patch)
+                    throw std::runtime_error(fmt::format("Unable to open {}", *patch_path));
+            }
+
+            Delta delta(
+                read_manifest(*base_manifest_path),
+                program.present("--base"),
+                patch_path ? &patch : nullptr);
+            auto file      = open_output(output);
+            missing_binary = unp->write_binaries(file.get(), delta, manifest);
+            delta_stats    = delta.stats;
+            if (patch_path && !patch.flush())
+                throw std::runtime_error(fmt::format("Unable to write the patch {}", *patch_path));
+        } catch (const std::exception& err) {
+            logger.error("Error: {}\n", err.what());
+            return 2;
+        }
+    } else if (output == "-") {
         if (std::ferror(std::freopen(nullptr, "wb", stdout)))
             throw std::runtime_error(std::strerror(errno));
 
-        missing_binary = unp->write_binaries(std::cout);
+        missing_binary = write_output(std::cout);
     } else {
         std::ofstream file(output, std::ios::binary);
-        missing_binary = unp->write_binaries(file);
+        missing_binary = write_output(file);
     }
 
     logger.log_done(tps, "Writing to file");
@@ -121,6 +272,34 @@ int main(int argc, char const* argv[]) {
         return 2;
     }
 
+    if (delta_stats) {
+        const auto& fmt_size = [](uint64_t size) {
+            return utils::fmt_unit({ "B", "kB", "MB", "GB" }, static_cast<double>(size));
+        };
+        logger.info(
+            "Unchanged binaries: {} ({}), changed binaries: {} ({})\n",
+            delta_stats->unchanged,
+            fmt_size(delta_stats->unchanged_size),
+            delta_stats->changed,
+            fmt_size(delta_stats->changed_size));
+    }
+
+    if (manifest_path) {
+        logger.info("Writing manifest {} ", *manifest_path);
+        std::ofstream file(*manifest_path);
+        if (!file) {
+            logger.error("Unable to open {}: {}\n", *manifest_path, std::strerror(errno));
+            return 2;
+        }
+
+        manifest.write(file);
+        if (file.flush().fail()) {
+            logger.error("Unable to write the manifest {}\n", *manifest_path);
+            return 2;
+        }
+        logger.log_done(tps, "Writing manifest");
+    }
+
     logger.display_statistics(tps);
     return 0;
 }
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <errno.h>
 #include <fmt/format.h>
+#include <fstream>
 #include <list>
 #include <ratio>
 #include <stdexcept>
@@ -36,6 +37,17 @@ void read_from_stdin(std::vector<uint8_t>& file) {
     }
 }
 
+void read_from_file(std::string const& path, std::vector<uint8_t>& file) {
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+        throw std::runtime_error(fmt::format("Unable to open {}: {}", path, std::strerror(errno)));
+
+    file.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(file.data()), file.size()))
+        throw std::runtime_error(fmt::format("Unable to read {}", path));
+}
+
 std::string get_unit(std::list<std::string> const& units, double& value, double factor) {
     auto it = units.begin();
     while (value >= factor && ++it != units.end())